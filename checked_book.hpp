@@ -0,0 +1,272 @@
+// Reference std::set order book and a wrapper that checks another book
+// against it, used by logbot (with CHECK_BOOKS) and the replay tool.
+
+#pragma once
+
+#include "client.hpp"
+#include <cassert>
+#include <iostream>
+#include <fstream>
+
+#include <set>
+#include <unordered_map>
+
+// Set Orders
+//
+// SetBook's resting order; the set orders them by price, then arrival.
+struct SetOrder {
+  tick_t price;
+  mutable quantity_t quantity; // mutable so set doesn't complain
+  order_id_t order_id;
+  long long time;
+  trader_id_t trader_id;
+  bool buy;
+
+  bool operator <(const SetOrder& other) const {
+    // < means more aggressive
+    if (buy) {
+      return price > other.price || (price == other.price && time < other.time);
+    } else {
+      return price < other.price || (price == other.price && time < other.time);
+    }
+  }
+
+  bool trades_with(const SetOrder& other) const {
+    return ((buy && !other.buy && price >= other.price) ||
+            (!buy && other.buy && price <= other.price));
+  }
+};
+
+// Set Book
+//
+// The original std::set book. Slow, but simple enough to trust, so it is
+// kept as the reference MyBook is checked against.
+struct SetBook {
+public:
+
+  SetBook() {}
+
+  tick_t get_bbo(bool buy) const {
+    const std::set<SetOrder>& side = sides[buy];
+
+    if (side.empty()) {
+      return 0;
+    }
+    return side.begin()->price;
+  }
+
+  price_t get_mid_price(price_t default_to) const {
+    tick_t best_bid = get_bbo(true);
+    tick_t best_offer = get_bbo(false);
+
+    if (best_bid == 0 || best_offer == 0) {
+      return default_to;
+    }
+    return 0.5 * Common::to_price(best_bid + best_offer);
+  }
+
+
+  void insert(Common::Order order_to_insert) {
+
+    SetOrder order_left = {
+      .price = Common::to_ticks(order_to_insert.price),
+      .quantity = order_to_insert.quantity,
+      .order_id = order_to_insert.order_id,
+      .time = next_time++,
+      .trader_id = order_to_insert.trader_id,
+      .buy = order_to_insert.buy
+    };
+
+    auto& side = sides[(size_t)order_left.buy];
+
+    auto it_new = side.insert(order_left);
+    assert(it_new.second);
+    order_map[order_left.order_id] = it_new.first;
+
+  }
+
+  void cancel(trader_id_t trader_id, order_id_t order_id) {
+
+    if (!order_map.count(order_id)) {
+      return;
+    }
+
+    auto it = order_map[order_id];
+
+    order_map.erase(order_id);
+
+    auto& side = sides[(size_t)it->buy];
+    side.erase(it);
+  }
+
+  quantity_t decrease_qty(order_id_t order_id, quantity_t decrease_by) {
+
+    if (!order_map.count(order_id)) {
+      return -1;
+    }
+
+    std::set<SetOrder>::iterator it = order_map[order_id];
+
+    if (decrease_by >= it->quantity) {
+      order_map.erase(order_id);
+      std::set<SetOrder>& side = sides[(size_t)it->buy];
+      side.erase(it);
+      return 0;
+
+    } else {
+
+      it->quantity -= decrease_by;
+      return it->quantity;
+    }
+
+  }
+
+  void print_book(std::string fp, const OrderIdMap<Common::Order>& mine={}) const {
+    if (fp == "") {
+      return;
+    }
+
+    std::ofstream fout(fp, std::ios::app);
+
+    fout << time_ns() << std::endl;
+    fout << "offers\n";
+    for (auto rit = sides[0].rbegin(); rit != sides[0].rend(); rit++) {
+      auto x = *rit;
+      fout << Common::to_price(x.price) << ' ' << x.quantity;
+      if (mine.count(x.order_id)) {
+        fout << " (mine)";
+      }
+      fout << '\n';
+    }
+
+    fout << "\nbids\n";
+
+    for (auto& x : sides[1]) {
+      fout << Common::to_price(x.price) << ' ' << x.quantity;
+      if (mine.count(x.order_id)) {
+        fout << " (mine)";
+      }
+      fout << '\n';
+    }
+
+    fout << "EOF" << std::endl;
+
+
+    fout.close();
+  }
+
+
+  quantity_t quote_size(bool buy) const {
+    tick_t p = get_bbo(buy);
+    if (p == 0) {
+      return 0;
+    }
+    quantity_t ans = 0;
+    for (auto& x : sides[buy]) {
+      if (x.price != p) {
+        break;
+      }
+      ans += x.quantity;
+    }
+    return ans;
+  }
+
+  /// Id of the first order in time priority at price, or 0 if there is none.
+  order_id_t first_at(bool buy, tick_t price) const {
+    const std::set<SetOrder>& side = sides[buy];
+    auto it = side.lower_bound(SetOrder{.price = price, .time = -1, .buy = buy});
+    if (it == side.end() || it->price != price) {
+      return 0;
+    }
+    return it->order_id;
+  }
+
+  tick_t spread() const {
+
+    tick_t best_bid = get_bbo(true);
+    tick_t best_offer = get_bbo(false);
+
+    if (best_bid == 0 || best_offer == 0) {
+      return 0;
+    }
+
+    return best_offer - best_bid;
+  }
+
+private:
+  std::set<SetOrder> sides[2];
+  std::unordered_map<order_id_t, std::set<SetOrder>::iterator> order_map;
+  long long next_time = 0;
+};
+
+// Checked Book
+//
+// Applies every update to both A and B and asserts that they agree on the
+// top of book afterwards. Nothing is recorded, so it can run for a whole
+// session.
+template <typename A, typename B>
+struct CheckedBook {
+public:
+
+  tick_t get_bbo(bool buy) const {
+    return a.get_bbo(buy);
+  }
+
+  price_t get_mid_price(price_t default_to) const {
+    return a.get_mid_price(default_to);
+  }
+
+  void insert(Common::Order order_to_insert) {
+    a.insert(order_to_insert);
+    b.insert(order_to_insert);
+    check();
+  }
+
+  void cancel(trader_id_t trader_id, order_id_t order_id) {
+    a.cancel(trader_id, order_id);
+    b.cancel(trader_id, order_id);
+    check();
+  }
+
+  quantity_t decrease_qty(order_id_t order_id, quantity_t decrease_by) {
+    quantity_t left = a.decrease_qty(order_id, decrease_by);
+    quantity_t left_b = b.decrease_qty(order_id, decrease_by);
+    assert(left == left_b);
+    check();
+    return left;
+  }
+
+  void print_book(std::string fp, const OrderIdMap<Common::Order>& mine={}) const {
+    a.print_book(fp, mine);
+  }
+
+  quantity_t quote_size(bool buy) const {
+    return a.quote_size(buy);
+  }
+
+  tick_t spread() const {
+    return a.spread();
+  }
+
+  size_t num_events() const {
+    return events;
+  }
+
+private:
+  void check() {
+    events++;
+    for (bool buy : {false, true}) {
+      if (a.get_bbo(buy) != b.get_bbo(buy) || a.quote_size(buy) != b.quote_size(buy)) {
+        std::cerr << "BOOK MISMATCH after event " << events
+                  << (buy ? " bid " : " offer ")
+                  << a.get_bbo(buy) << 'x' << a.quote_size(buy) << " vs "
+                  << b.get_bbo(buy) << 'x' << b.quote_size(buy) << std::endl;
+        assert(false);
+      }
+    }
+  }
+
+  A a;
+  B b;
+  size_t events = 0;
+};
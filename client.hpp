@@ -0,0 +1,829 @@
+// Client-side order book and trading state, shared by the bots in
+// competitor.cpp and logbot.cpp and by the replay tool.
+
+#pragma once
+
+#include "kirin.hpp"
+#include "flat_hash_map.hpp"
+#include <cassert>
+#include <fstream>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+
+inline int64_t time_ns() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// PRICING TYPE 1
+inline price_t cube_root_price(tick_t best_bid, tick_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
+  const quantity_t bid_weight = std::cbrt(offer_quote_size);
+  const quantity_t offer_weight = std::cbrt(bid_quote_size);
+  return Common::to_price(bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
+}
+// PRICING TYPE 2
+inline price_t square_root_price(tick_t best_bid, tick_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
+  const quantity_t bid_weight = std::sqrt(offer_quote_size);
+  const quantity_t offer_weight = std::sqrt(bid_quote_size);
+  return Common::to_price(bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
+}
+
+// PRICING TYPE 3
+inline price_t weighted_price(tick_t best_bid, tick_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
+  const quantity_t bid_weight = offer_quote_size;
+  const quantity_t offer_weight = bid_quote_size;
+  return Common::to_price(bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
+}
+
+// PRICING TYPE 4
+inline price_t square_price(tick_t best_bid, tick_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
+  const quantity_t bid_weight = offer_quote_size * offer_quote_size;
+  const quantity_t offer_weight = bid_quote_size * bid_quote_size;
+  return Common::to_price(bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
+}
+
+// Order Id Maps
+//
+// Order ids come out of Communicator::random_order_id uniformly at random, so
+// their low bits already spread evenly over a power-of-two table and can be
+// used as the hash directly.
+struct OrderIdHash {
+  typedef ska::power_of_two_hash_policy hash_policy;
+
+  size_t operator()(order_id_t order_id) const {
+    return order_id;
+  }
+};
+
+template <typename V>
+using OrderIdMap = ska::flat_hash_map<order_id_t, V, OrderIdHash>;
+typedef ska::flat_hash_set<order_id_t, OrderIdHash> OrderIdSet;
+
+// Limit Orders
+//
+// Lives in an OrderPool slot and is linked into its price level's FIFO, so
+// list order is time priority.
+struct LimitOrder {
+  tick_t price;
+  quantity_t quantity;
+  order_id_t order_id;
+  trader_id_t trader_id;
+  bool buy;
+  uint32_t prev;
+  uint32_t next;
+
+  bool trades_with(const LimitOrder& other) const {
+    return ((buy && !other.buy && price >= other.price) ||
+            (!buy && other.buy && price <= other.price));
+  }
+};
+
+const uint32_t NO_SLOT = UINT32_MAX;
+
+// Order Pool
+//
+// Slots for resting orders, recycled through a free list threaded through
+// `next`. Slots are addressed by index, so growing the pool never
+// invalidates a slot held by the book.
+struct OrderPool {
+  static constexpr size_t INITIAL_CAPACITY = 4096;
+
+  OrderPool() : slots(), free_head(NO_SLOT) {}
+
+  uint32_t alloc() {
+    if (free_head != NO_SLOT) {
+      uint32_t slot = free_head;
+      free_head = slots[slot].next;
+      return slot;
+    }
+
+    if (slots.capacity() == 0) {
+      slots.reserve(INITIAL_CAPACITY);
+    }
+    slots.emplace_back();
+    return slots.size() - 1;
+  }
+
+  void release(uint32_t slot) {
+    slots[slot].next = free_head;
+    free_head = slot;
+  }
+
+  LimitOrder& operator[](uint32_t slot) {
+    return slots[slot];
+  }
+
+  const LimitOrder& operator[](uint32_t slot) const {
+    return slots[slot];
+  }
+
+private:
+  std::vector<LimitOrder> slots;
+  uint32_t free_head;
+};
+
+// Price Levels
+//
+// Aggregate of all resting orders at one price on one side of the book,
+// plus the head and tail of their FIFO in the pool.
+struct PriceLevel {
+  quantity_t quantity = 0;
+  int count = 0;
+  uint32_t head = NO_SLOT;
+  uint32_t tail = NO_SLOT;
+};
+
+// Level Ladder
+//
+// One side's price levels in a flat array indexed by tick offset from
+// `anchor`. A two-level occupancy bitmap (one bit per level, one summary bit
+// per word) finds the best level with a clz/ctz per layer. Levels that fall
+// outside the window go to `overflow`; the window recentres whenever it
+// empties, so it follows the market without moving live levels around.
+struct LevelLadder {
+  static constexpr int WINDOW_BITS = 10;
+  static constexpr tick_t WINDOW = (tick_t)1 << WINDOW_BITS;
+  static constexpr int WORDS = WINDOW / 64;
+
+  LevelLadder(bool buy) :
+    buy(buy), anchor(0), active(0), summary(0), occupied(), levels(), overflow() {}
+
+  // Best price on this side, or 0 if the side is empty.
+  tick_t best() const {
+    tick_t best_price = 0;
+
+    if (summary) {
+      if (buy) {
+        int w = 63 - __builtin_clzll(summary);
+        best_price = anchor + w * 64 + (63 - __builtin_clzll(occupied[w]));
+      } else {
+        int w = __builtin_ctzll(summary);
+        best_price = anchor + w * 64 + __builtin_ctzll(occupied[w]);
+      }
+    }
+
+    if (!overflow.empty()) {
+      tick_t p = buy ? overflow.rbegin()->first : overflow.begin()->first;
+      if (best_price == 0 || (buy ? p > best_price : p < best_price)) {
+        best_price = p;
+      }
+    }
+
+    return best_price;
+  }
+
+  const PriceLevel* find(tick_t price) const {
+    if (in_window(price)) {
+      tick_t i = price - anchor;
+      return (occupied[i >> 6] >> (i & 63)) & 1 ? &levels[i] : nullptr;
+    }
+    auto it = overflow.find(price);
+    return it == overflow.end() ? nullptr : &it->second;
+  }
+
+  PriceLevel* find(tick_t price) {
+    return const_cast<PriceLevel*>(static_cast<const LevelLadder&>(*this).find(price));
+  }
+
+  // Returns the level at price, creating an empty one if needed.
+  PriceLevel& get(tick_t price) {
+    if (!in_window(price) && active == 0) {
+      recentre(price);
+    }
+
+    if (!in_window(price)) {
+      return overflow[price];
+    }
+
+    tick_t i = price - anchor;
+    if (!((occupied[i >> 6] >> (i & 63)) & 1)) {
+      occupied[i >> 6] |= 1ULL << (i & 63);
+      summary |= 1ULL << (i >> 6);
+      levels[i] = PriceLevel();
+      active++;
+    }
+    return levels[i];
+  }
+
+  void erase(tick_t price) {
+    if (!in_window(price)) {
+      overflow.erase(price);
+      return;
+    }
+
+    tick_t i = price - anchor;
+    occupied[i >> 6] &= ~(1ULL << (i & 63));
+    if (!occupied[i >> 6]) {
+      summary &= ~(1ULL << (i >> 6));
+    }
+
+    if (--active == 0 && !overflow.empty()) {
+      recentre(best());
+    }
+  }
+
+  // Calls f(price, level) from the lowest price up (or highest down) until
+  // it returns false.
+  template <typename F>
+  void visit(bool ascending, F f) const {
+    if (ascending) {
+      auto it = overflow.begin();
+      for (; it != overflow.end() && it->first < anchor; ++it) {
+        if (!f(it->first, it->second)) return;
+      }
+      for (uint64_t words = summary; words; words &= words - 1) {
+        int w = __builtin_ctzll(words);
+        for (uint64_t bits = occupied[w]; bits; bits &= bits - 1) {
+          tick_t i = w * 64 + __builtin_ctzll(bits);
+          if (!f(anchor + i, levels[i])) return;
+        }
+      }
+      for (; it != overflow.end(); ++it) {
+        if (!f(it->first, it->second)) return;
+      }
+    } else {
+      auto it = overflow.rbegin();
+      for (; it != overflow.rend() && it->first >= anchor + WINDOW; ++it) {
+        if (!f(it->first, it->second)) return;
+      }
+      for (uint64_t words = summary; words; words &= ~(1ULL << (63 - __builtin_clzll(words)))) {
+        int w = 63 - __builtin_clzll(words);
+        for (uint64_t bits = occupied[w]; bits; bits &= ~(1ULL << (63 - __builtin_clzll(bits)))) {
+          tick_t i = w * 64 + (63 - __builtin_clzll(bits));
+          if (!f(anchor + i, levels[i])) return;
+        }
+      }
+      for (; it != overflow.rend(); ++it) {
+        if (!f(it->first, it->second)) return;
+      }
+    }
+  }
+
+private:
+  bool in_window(tick_t price) const {
+    return !levels.empty() && price >= anchor && price < anchor + WINDOW;
+  }
+
+  // Only called with an empty window: move it to centre on price and pull
+  // in any overflow levels that now fit.
+  void recentre(tick_t price) {
+    if (levels.empty()) {
+      levels.resize(WINDOW);
+    }
+    anchor = price - WINDOW / 2;
+
+    auto it = overflow.lower_bound(anchor);
+    while (it != overflow.end() && it->first < anchor + WINDOW) {
+      PriceLevel& level = get(it->first);
+      level = it->second;
+      it = overflow.erase(it);
+    }
+  }
+
+  bool buy;
+  tick_t anchor;
+  int active;
+  uint64_t summary;
+  uint64_t occupied[WORDS];
+  std::vector<PriceLevel> levels;
+  std::map<tick_t, PriceLevel> overflow;
+};
+
+// Depth Levels
+//
+// One aggregated price level as reported by MyBook::depth.
+struct DepthLevel {
+  tick_t price;
+  quantity_t quantity;
+  int count;
+};
+
+// MyBook
+//
+struct MyBook {
+public:
+
+  MyBook() : levels{LevelLadder(false), LevelLadder(true)} {}
+
+  tick_t get_bbo(bool buy) const {
+    return levels[buy].best();
+  }
+
+  price_t get_mid_price(price_t default_to) const {
+    tick_t best_bid = get_bbo(true);
+    tick_t best_offer = get_bbo(false);
+
+    if (best_bid == 0 || best_offer == 0) {
+      return default_to;
+    }
+    return 0.5 * Common::to_price(best_bid + best_offer);
+  }
+
+
+  void insert(Common::Order order_to_insert) {
+
+    uint32_t slot = pool.alloc();
+    LimitOrder& order = pool[slot];
+    order = LimitOrder{
+      .price = Common::to_ticks(order_to_insert.price),
+      .quantity = order_to_insert.quantity,
+      .order_id = order_to_insert.order_id,
+      .trader_id = order_to_insert.trader_id,
+      .buy = order_to_insert.buy,
+      .prev = NO_SLOT,
+      .next = NO_SLOT
+    };
+
+    PriceLevel& level = levels[(size_t)order.buy].get(order.price);
+    order.prev = level.tail;
+    if (level.tail != NO_SLOT) {
+      pool[level.tail].next = slot;
+    } else {
+      level.head = slot;
+    }
+    level.tail = slot;
+    level.quantity += order.quantity;
+    level.count++;
+
+    auto it_new = order_map.emplace(order.order_id, slot);
+    assert(it_new.second);
+  }
+
+  void cancel(trader_id_t trader_id, order_id_t order_id) {
+
+    auto it = order_map.find(order_id);
+    if (it == order_map.end()) {
+      return;
+    }
+
+    uint32_t slot = it->second;
+    order_map.erase(it);
+
+    remove_order(slot);
+  }
+
+  quantity_t decrease_qty(order_id_t order_id, quantity_t decrease_by) {
+
+    auto it = order_map.find(order_id);
+    if (it == order_map.end()) {
+      return -1;
+    }
+
+    uint32_t slot = it->second;
+    LimitOrder& order = pool[slot];
+
+    if (decrease_by >= order.quantity) {
+      order_map.erase(it);
+      remove_order(slot);
+      return 0;
+
+    } else {
+
+      levels[(size_t)order.buy].find(order.price)->quantity -= decrease_by;
+      order.quantity -= decrease_by;
+      return order.quantity;
+    }
+
+  }
+
+  void print_book(std::string fp, const OrderIdMap<Common::Order>& mine={}) const {
+    if (fp == "") {
+      return;
+    }
+
+    std::ofstream fout(fp, std::ios::app);
+
+    auto print_order = [&](const LimitOrder& x) {
+      fout << Common::to_price(x.price) << ' ' << x.quantity;
+      if (mine.count(x.order_id)) {
+        fout << " (mine)";
+      }
+      fout << '\n';
+    };
+
+    fout << time_ns() << std::endl;
+    fout << "offers\n";
+    levels[0].visit(false, [&](tick_t price, const PriceLevel& level) {
+      for (uint32_t slot = level.tail; slot != NO_SLOT; slot = pool[slot].prev) {
+        print_order(pool[slot]);
+      }
+      return true;
+    });
+
+    fout << "\nbids\n";
+
+    levels[1].visit(false, [&](tick_t price, const PriceLevel& level) {
+      for (uint32_t slot = level.head; slot != NO_SLOT; slot = pool[slot].next) {
+        print_order(pool[slot]);
+      }
+      return true;
+    });
+
+    fout << "EOF" << std::endl;
+
+
+    fout.close();
+  }
+
+
+  /// Total quantity and number of orders resting at price on one side.
+  PriceLevel level_at(bool buy, tick_t price) const {
+    const PriceLevel* level = levels[buy].find(price);
+    if (level == nullptr) {
+      return PriceLevel{0, 0};
+    }
+    return *level;
+  }
+
+  quantity_t depth_at(bool buy, tick_t price) const {
+    return level_at(buy, price).quantity;
+  }
+
+  /// Writes up to n of the best levels on one side into out, best first, and
+  /// returns how many were written. Does not allocate.
+  size_t depth(bool buy, size_t n, DepthLevel* out) const {
+    size_t filled = 0;
+    if (n == 0) {
+      return 0;
+    }
+
+    levels[buy].visit(!buy, [&](tick_t price, const PriceLevel& level) {
+      out[filled++] = DepthLevel{price, level.quantity, level.count};
+      return filled < n;
+    });
+    return filled;
+  }
+
+  template <size_t N>
+  size_t depth(bool buy, DepthLevel (&out)[N]) const {
+    return depth(buy, N, out);
+  }
+
+  quantity_t quote_size(bool buy) const {
+    tick_t p = get_bbo(buy);
+    if (p == 0) {
+      return 0;
+    }
+    return depth_at(buy, p);
+  }
+
+  tick_t spread() const {
+
+    tick_t best_bid = get_bbo(true);
+    tick_t best_offer = get_bbo(false);
+
+    if (best_bid == 0 || best_offer == 0) {
+      return 0;
+    }
+
+    return best_offer - best_bid;
+  }
+
+private:
+  // Unlinks the order from its level's FIFO and returns its slot to the pool.
+  void remove_order(uint32_t slot) {
+    LimitOrder& order = pool[slot];
+    LevelLadder& side_levels = levels[(size_t)order.buy];
+    PriceLevel* level = side_levels.find(order.price);
+    assert(level != nullptr);
+
+    if (order.prev != NO_SLOT) {
+      pool[order.prev].next = order.next;
+    } else {
+      level->head = order.next;
+    }
+    if (order.next != NO_SLOT) {
+      pool[order.next].prev = order.prev;
+    } else {
+      level->tail = order.prev;
+    }
+
+    level->quantity -= order.quantity;
+    if (--level->count == 0) {
+      side_levels.erase(order.price);
+    }
+
+    pool.release(slot);
+  }
+
+  OrderPool pool;
+  LevelLadder levels[2];
+  OrderIdMap<uint32_t> order_map;
+};
+
+// Own Levels
+//
+// Our own resting quantity and order ids at one price on one side.
+struct OwnLevel {
+  quantity_t quantity;
+  std::vector<order_id_t> order_ids;
+};
+
+// Packet Updates
+//
+// One update from a packet, tagged with its type.
+struct PacketUpdate {
+  Common::UpdateType type;
+  union {
+    Common::TradeUpdate trade;
+    Common::OrderUpdate order;
+    Common::CancelUpdate cancel;
+    Common::RejectOrderUpdate reject_order;
+    Common::RejectCancelUpdate reject_cancel;
+  };
+};
+
+// My State
+//
+// Book is the per-ticker order book: MyBook, or anything with the same
+// interface, such as the CheckedBook logbot can run with.
+//
+//
+//
+//
+//
+template <typename Book>
+struct MyState {
+  MyState(trader_id_t trader_id) :
+    trader_id(trader_id), ticker_states(), tickers(), submitted(), open_orders(),
+    cash(), positions(), marks(), position_value(), volume_traded(),
+    last_trade_price(Common::to_ticks(100.0)),
+    log_path("") {}
+
+  MyState() : MyState(0) {}
+
+  void on_trade_update(const Common::TradeUpdate& update) {
+    const tick_t price = Common::to_ticks(update.price);
+    last_trade_price = price;
+    book(update.ticker).decrease_qty(update.resting_order_id, update.quantity);
+
+    // the last trade price is the fallback mark for every one-sided book
+    for (ticker_t ticker : tickers) {
+      if (positions[ticker] != 0) {
+        remark(ticker);
+      }
+    }
+
+    if (submitted.count(update.resting_order_id)) {
+
+      if (!submitted.count(update.aggressing_order_id)) {
+        volume_traded += update.quantity;
+        // not a self-trade
+        update_position(update.ticker, price,
+                        update.buy ? -update.quantity : update.quantity); // opposite, since resting
+      }
+
+      auto it = open_orders.find(update.resting_order_id);
+      if (it != open_orders.end()) {
+        Common::Order& order = it->second;
+        quantity_t filled = std::min(update.quantity, order.quantity);
+        order.quantity -= update.quantity;
+        remove_own_order(order, filled, order.quantity <= 0);
+        if (order.quantity <= 0) {
+          open_orders.erase(it);
+        }
+      }
+
+    } else if (submitted.count(update.aggressing_order_id)) {
+      volume_traded += update.quantity;
+
+      update_position(update.ticker, price,
+                      update.buy ? update.quantity : -update.quantity);
+    }
+  }
+
+  void update_position(ticker_t ticker, tick_t price, quantity_t delta_quantity) {
+    remark(ticker);
+    cash -= price * delta_quantity;
+    positions[ticker] += delta_quantity;
+    position_value += delta_quantity * marks[ticker];
+  }
+
+  // Marks ticker at its current mid (in half ticks), carrying the change
+  // into position_value.
+  void remark(ticker_t ticker) {
+    const Book& ticker_book = book(ticker);
+    tick_t best_bid = ticker_book.get_bbo(true);
+    tick_t best_offer = ticker_book.get_bbo(false);
+    tick_t mark = (best_bid == 0 || best_offer == 0) ? 2 * last_trade_price : best_bid + best_offer;
+
+    position_value += positions[ticker] * (mark - marks[ticker]);
+    marks[ticker] = mark;
+  }
+
+  void on_order_update(const Common::OrderUpdate& update) {
+
+    const Common::Order order{
+      .ticker = update.ticker,
+      .price = update.price,
+      .quantity = update.quantity,
+      .buy = update.buy,
+      .ioc = false,
+      .order_id = update.order_id,
+      .trader_id = trader_id
+    };
+    book(update.ticker).insert(order);
+    if (positions[update.ticker] != 0) {
+      remark(update.ticker);
+    }
+
+    if (submitted.count(update.order_id)) {
+      open_orders[update.order_id] = order;
+
+      OwnLevel& level = ticker_state(order.ticker).own_levels[order.buy][Common::to_ticks(order.price)];
+      level.quantity += order.quantity;
+      level.order_ids.push_back(order.order_id);
+    }
+  }
+
+  void on_cancel_update(const Common::CancelUpdate& update) {
+    book(update.ticker).cancel(trader_id, update.order_id);
+    if (positions[update.ticker] != 0) {
+      remark(update.ticker);
+    }
+
+    auto it = open_orders.find(update.order_id);
+    if (it != open_orders.end()) {
+      remove_own_order(it->second, it->second.quantity, true);
+      open_orders.erase(it);
+    }
+
+    submitted.erase(update.order_id);
+  }
+
+  void on_place_order(const Common::Order& order) {
+    submitted.insert(order.order_id);
+  }
+
+  // Applies any book-changing update from a packet; rejects are ignored.
+  void apply(const PacketUpdate& update) {
+    switch (update.type) {
+      case Common::TRADE: on_trade_update(update.trade); break;
+      case Common::ORDER: on_order_update(update.order); break;
+      case Common::CANCEL: on_cancel_update(update.cancel); break;
+      default: break;
+    }
+  }
+
+
+  /// Our resting orders at price, or nullptr if we have none there.
+  const OwnLevel* own_level(ticker_t ticker, bool buy, tick_t price) const {
+    const auto& own_levels = ticker_state(ticker).own_levels[buy];
+    auto it = own_levels.find(price);
+    return it == own_levels.end() ? nullptr : &it->second;
+  }
+
+  quantity_t own_quantity_at(ticker_t ticker, bool buy, tick_t price) const {
+    const OwnLevel* level = own_level(ticker, buy, price);
+    return level == nullptr ? 0 : level->quantity;
+  }
+
+  // Cash plus positions marked to mid, kept up to date on every update.
+  price_t get_pnl() const {
+    return 0.5 * Common::to_price(2 * cash + position_value);
+  }
+
+  tick_t get_bbo(ticker_t ticker, bool buy) const {
+    return book(ticker).get_bbo(buy);
+  }
+
+  price_t get_mid_price(ticker_t ticker, bool buy) const {
+    return book(ticker).get_mid_price(buy);
+  }
+
+  quantity_t get_quote_size(ticker_t ticker, bool buy) const {
+    return book(ticker).quote_size(buy);
+  }
+
+  tick_t get_spread(ticker_t ticker) const {
+    return book(ticker).spread();
+  }
+
+  size_t get_depth(ticker_t ticker, bool buy, size_t n, DepthLevel* out) const {
+    return book(ticker).depth(buy, n, out);
+  }
+
+  void log_book() {
+    book(0).print_book(log_path, open_orders);
+  }
+
+  // Everything we track for one ticker, created on its first update.
+  struct TickerState {
+    Book book;
+    ska::flat_hash_map<tick_t, OwnLevel> own_levels[2];
+  };
+
+  TickerState& ticker_state(ticker_t ticker) {
+    if (!ticker_states[ticker]) {
+      ticker_states[ticker].reset(new TickerState());
+      tickers.push_back(ticker);
+    }
+    return *ticker_states[ticker];
+  }
+
+  const TickerState& ticker_state(ticker_t ticker) const {
+    static const TickerState empty_state;
+    return ticker_states[ticker] ? *ticker_states[ticker] : empty_state;
+  }
+
+  Book& book(ticker_t ticker) {
+    return ticker_state(ticker).book;
+  }
+
+  const Book& book(ticker_t ticker) const {
+    return ticker_state(ticker).book;
+  }
+
+  // Takes quantity off our level at the order's price, and the order id too
+  // if the order is leaving the book.
+  void remove_own_order(const Common::Order& order, quantity_t quantity, bool removes_order) {
+    auto& own_levels = ticker_state(order.ticker).own_levels[order.buy];
+    auto it = own_levels.find(Common::to_ticks(order.price));
+    if (it == own_levels.end()) {
+      return;
+    }
+
+    OwnLevel& level = it->second;
+    level.quantity -= quantity;
+    if (removes_order) {
+      auto id = std::find(level.order_ids.begin(), level.order_ids.end(), order.order_id);
+      if (id != level.order_ids.end()) {
+        *id = level.order_ids.back();
+        level.order_ids.pop_back();
+      }
+      if (level.order_ids.empty()) {
+        own_levels.erase(it);
+      }
+    }
+  }
+
+  trader_id_t trader_id;
+  std::unique_ptr<TickerState> ticker_states[MAX_NUM_TICKERS];
+  std::vector<ticker_t> tickers; // tickers with state, in order of first update
+  OrderIdSet submitted;
+  OrderIdMap<Common::Order> open_orders;
+  tick_t cash; // in ticks
+  quantity_t positions[MAX_NUM_TICKERS];
+  tick_t marks[MAX_NUM_TICKERS]; // mid in half ticks, current while we hold a position
+  tick_t position_value; // sum of positions * marks, in half ticks
+  quantity_t volume_traded;
+  tick_t last_trade_price;
+  std::string log_path;
+
+};
+
+// Packet Bot
+//
+// Opt-in alternative to the per-update callbacks: the updates of a packet
+// are collected as they arrive and handed to on_packet() as one array when
+// the packet ends, so a strategy can apply every book change first and
+// make one decision per packet.
+class PacketBot : public Bot::AbstractBot {
+
+public:
+
+  using Bot::AbstractBot::AbstractBot;
+
+  virtual void on_packet(const PacketUpdate* updates, size_t n, Bot::Communicator& com) = 0;
+
+  void on_trade_update(Common::TradeUpdate& update, Bot::Communicator& com) final {
+    push(Common::TRADE).trade = update;
+  }
+
+  void on_order_update(Common::OrderUpdate& update, Bot::Communicator& com) final {
+    push(Common::ORDER).order = update;
+  }
+
+  void on_cancel_update(Common::CancelUpdate& update, Bot::Communicator& com) final {
+    push(Common::CANCEL).cancel = update;
+  }
+
+  void on_reject_order_update(Common::RejectOrderUpdate& update, Bot::Communicator& com) final {
+    push(Common::REJECT_ORDER).reject_order = update;
+  }
+
+  void on_reject_cancel_update(Common::RejectCancelUpdate& update, Bot::Communicator& com) final {
+    push(Common::REJECT_CANCEL).reject_cancel = update;
+  }
+
+  void on_packet_start(Bot::Communicator& com) final {
+    packet.clear();
+  }
+
+  void on_packet_end(Bot::Communicator& com) final {
+    on_packet(packet.data(), packet.size(), com);
+  }
+
+private:
+  PacketUpdate& push(Common::UpdateType type) {
+    packet.emplace_back();
+    packet.back().type = type;
+    return packet.back();
+  }
+
+  std::vector<PacketUpdate> packet; // cleared, not freed, between packets
+};
@@ -1,6 +1,7 @@
 // TODO: move ClientState and its OrderBook code into this file
 
 #include "kirin.hpp"
+#include "client.hpp"
 #include <cassert>
 #include <iostream>
 #include <iomanip>
@@ -8,9 +9,12 @@
 
 #include <algorithm>
 #include <chrono>
-#include <set>
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+#include <sched.h>
 #include <unordered_map>
-#include <unordered_set>
 
 #define DEBUG 0
 #define INFO 1
@@ -18,341 +22,80 @@
 #define TIME_INFO 1
 
 
-int64_t time_ns() {
-  using namespace std::chrono;
-  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
-}
-
-// PRICING TYPE 1
-price_t cube_root_price(price_t best_bid, price_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
-  const quantity_t bid_weight = std::cbrt(offer_quote_size);
-  const quantity_t offer_weight = std::cbrt(bid_quote_size);
-  return (bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
-}
-// PRICING TYPE 2
-price_t square_root_price(price_t best_bid, price_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
-  const quantity_t bid_weight = std::sqrt(offer_quote_size);
-  const quantity_t offer_weight = std::sqrt(bid_quote_size);
-  return (bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
-}
-
-// PRICING TYPE 3
-price_t weighted_price(price_t best_bid, price_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
-  const quantity_t bid_weight = offer_quote_size;
-  const quantity_t offer_weight = bid_quote_size;
-  return (bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
-}
-
-// PRICING TYPE 4
-price_t square_price(price_t best_bid, price_t best_offer, quantity_t bid_quote_size, quantity_t offer_quote_size) {
-  const quantity_t bid_weight = offer_quote_size * offer_quote_size;
-  const quantity_t offer_weight = bid_quote_size * bid_quote_size;
-  return (bid_weight * best_bid + offer_weight * best_offer) / (bid_weight + offer_weight);
-}
-
-// Limit Orders
-//
-struct LimitOrder {
-  price_t price;
-  mutable quantity_t quantity; // mutable so set doesn't complain
-  order_id_t order_id;
-  long long time;
-  trader_id_t trader_id;
-  bool buy;
-
-  bool operator <(const LimitOrder& other) const {
-    // < means more aggressive
-    if (buy) {
-      return price > other.price || (price == other.price && time < other.time);
-    } else {
-      return price < other.price || (price == other.price && time < other.time);
-    }
-  }
-
-  bool trades_with(const LimitOrder& other) const {
-    return ((buy && !other.buy && price >= other.price) ||
-            (!buy && other.buy && price <= other.price));
-  }
-};
-
-// MyBook
-//
-struct MyBook {
-public:
-
-  MyBook() {}
-
-  price_t get_bbo(bool buy) const {
-    const std::set<LimitOrder>& side = sides[buy];
-
-    if (side.empty()) {
-      return 0.0;
-    }
-    return side.begin()->price;
-  }
-
-  price_t get_mid_price(price_t default_to) const {
-    price_t best_bid = get_bbo(true);
-    price_t best_offer = get_bbo(false);
-
-    if (best_bid == 0.0 || best_offer == 0.0) {
-      return default_to;
-    }
-    return 0.5 * (best_bid + best_offer);
-  }
-
-
-  void insert(Common::Order order_to_insert) {
-
-    LimitOrder order_left = {
-      .price = order_to_insert.price,
-      .quantity = order_to_insert.quantity,
-      .order_id = order_to_insert.order_id,
-      .time = std::chrono::steady_clock::now().time_since_epoch().count(),
-      .trader_id = order_to_insert.trader_id,
-      .buy = order_to_insert.buy
-    };
-
-    auto& side = sides[(size_t)order_left.buy];
-
-    auto it_new = side.insert(order_left);
-    assert(it_new.second);
-    order_map[order_left.order_id] = it_new.first;
-
-  }
-
-  void cancel(trader_id_t trader_id, order_id_t order_id) {
-
-    auto it = order_map[order_id];
-
-    order_map.erase(order_id);
-
-    auto& side = sides[(size_t)it->buy];
-    side.erase(it);
-  }
-
-  quantity_t decrease_qty(order_id_t order_id, quantity_t decrease_by) {
-
-    if (!order_map.count(order_id)) {
-      return -1;
-    }
-
-    std::set<LimitOrder>::iterator it = order_map[order_id];
-
-    if (decrease_by >= it->quantity) {
-      order_map.erase(order_id);
-      std::set<LimitOrder>& side = sides[(size_t)it->buy];
-      side.erase(it);
-      return 0;
-
-    } else {
-
-      it->quantity -= decrease_by;
-      return it->quantity;
-    }
-
-  }
-
-  void print_book(std::string fp, const std::unordered_map<order_id_t, Common::Order>& mine={}) {
-    if (fp == "") {
-      return;
-    }
-
-    std::ofstream fout(fp, std::ios::app);
-
-    fout << time_ns() << std::endl;
-    fout << "offers\n";
-    for (auto rit = sides[0].rbegin(); rit != sides[0].rend(); rit++) {
-      auto x = *rit;
-      fout << x.price << ' ' << x.quantity;
-      if (mine.count(x.order_id)) {
-        fout << " (mine)";
-      }
-      fout << '\n';
-    }
-
-    fout << "\nbids\n";
-
-    for (auto& x : sides[1]) {
-      fout << x.price << ' ' << x.quantity;
-      if (mine.count(x.order_id)) {
-        fout << " (mine)";
-      }
-      fout << '\n';
-    }
-
-    fout << "EOF" << std::endl;
-
-
-    fout.close();
-  }
-
-
-  /// Really fucking slow. Need to improve this.
-  quantity_t quote_size(bool buy) const {
-    price_t p = get_bbo(buy);
-    if (p == 0.0) {
-      return 0;
-    }
-    quantity_t ans = 0;
-    for (auto& x : sides[buy]) {
-      if (x.price != p) {
-        break;
-      }
-      ans += x.quantity;
-    }
-    return ans;
-  }
-
-  price_t spread() const {
-
-    price_t best_bid = get_bbo(true);
-    price_t best_offer = get_bbo(false);
-
-    if (best_bid == 0.0 || best_offer == 0.0) {
-      return 0.0;
-    }
-
-    return best_offer - best_bid;
-  }
-
-private:
-  std::set<LimitOrder> sides[2];
-  std::unordered_map<order_id_t, std::set<LimitOrder>::iterator> order_map;
-};
-
-// My State
-//
+// Thread Placement
 //
+// Configured through the environment, as cpu lists like "2-3,6":
 //
+//   KIRIN_CPUS       cpus for every thread Manager::run starts (exchange,
+//                    router, bots); applied to main() before run(), so the
+//                    threads inherit it
+//   KIRIN_FIFO       SCHED_FIFO priority for those threads
+//   KIRIN_BOT_CPUS   cpus for our bot's own thread, applied from init()
+//   KIRIN_BOT_FIFO   SCHED_FIFO priority for our bot's thread
 //
-//
-//
-//
-//
-struct MyState {
-  MyState(trader_id_t trader_id) :
-    trader_id(trader_id), books(), submitted(), open_orders(),
-    cash(), positions(), volume_traded(), last_trade_price(100.0),
-    log_path("") {}
-
-  MyState() : MyState(0) {}
-
-  void on_trade_update(const Common::TradeUpdate& update) {
-    last_trade_price = update.price;
-    books[update.ticker].decrease_qty(update.resting_order_id, update.quantity);
-
-    if (submitted.count(update.resting_order_id)) {
-
-      if (!submitted.count(update.aggressing_order_id)) {
-        volume_traded += update.quantity;
-        // not a self-trade
-        update_position(update.ticker, update.price,
-                        update.buy ? -update.quantity : update.quantity); // opposite, since resting
-      }
-
-      open_orders[update.resting_order_id].quantity -= update.quantity;
-      if (open_orders[update.resting_order_id].quantity <= 0) {
-        open_orders.erase(update.resting_order_id);
-      }
-
-    } else if (submitted.count(update.aggressing_order_id)) {
-      volume_traded += update.quantity;
-
-      update_position(update.ticker, update.price,
-                      update.buy ? update.quantity : -update.quantity);
+// Manager::run is prebuilt, so the exchange and router threads can only be
+// placed as a group.
+bool parse_cpu_list(const std::string& list, cpu_set_t& cpus) {
+  CPU_ZERO(&cpus);
+
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    size_t dash = range.find('-');
+    int lo, hi;
+    try {
+      lo = std::stoi(range.substr(0, dash));
+      hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+    } catch (const std::exception&) {
+      return false;
     }
-  }
-
-  void update_position(ticker_t ticker, price_t price, quantity_t delta_quantity) {
-    cash -= price * delta_quantity;
-    positions[ticker] += delta_quantity;
-  }
-
-  void on_order_update(const Common::OrderUpdate& update) {
-
-    const Common::Order order{
-      .ticker = update.ticker,
-      .price = update.price,
-      .quantity = update.quantity,
-      .buy = update.buy,
-      .ioc = false,
-      .order_id = update.order_id,
-      .trader_id = trader_id
-    };
-    books[update.ticker].insert(order);
-
-    if (submitted.count(update.order_id)) {
-      open_orders[update.order_id] = order;
+    if (lo < 0 || hi < lo || hi >= CPU_SETSIZE) {
+      return false;
     }
-  }
-
-  void on_cancel_update(const Common::CancelUpdate& update) {
-    books[update.ticker].cancel(trader_id, update.order_id);
-
-    if (open_orders.count(update.order_id)) {
-      open_orders.erase(update.order_id);
-
+    for (int cpu = lo; cpu <= hi; cpu++) {
+      CPU_SET(cpu, &cpus);
     }
-
-    submitted.erase(update.order_id);
-  }
-
-  void on_place_order(const Common::Order& order) {
-    submitted.insert(order.order_id);
   }
+  return CPU_COUNT(&cpus) > 0;
+}
 
-
-  std::unordered_map<price_t, std::vector<Common::Order>> levels() const {
-    std::unordered_map<price_t, std::vector<Common::Order>> levels;
-    for (const auto& p : open_orders) {
-      const Common::Order& order = p.second;
-      levels[order.price].push_back(order);
+// Applies the placement named by cpus_env and fifo_env (either may be unset)
+// to the calling thread and reports where it ended up.
+void place_current_thread(const char* name, const char* cpus_env, const char* fifo_env) {
+  if (const char* list = std::getenv(cpus_env)) {
+    cpu_set_t cpus;
+    if (!parse_cpu_list(list, cpus)) {
+      std::cerr << "ignoring bad " << cpus_env << "=" << list << std::endl;
+    } else if (int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+      std::cerr << "could not set " << cpus_env << ": " << std::strerror(err) << std::endl;
     }
-    return levels;
   }
 
-  price_t get_pnl() const {
-    price_t pnl = cash;
-
-    for (int i = 0; i < MAX_NUM_TICKERS; i++) {
-      pnl += positions[i] * books[i].get_mid_price(last_trade_price);
+  if (const char* priority = std::getenv(fifo_env)) {
+    sched_param param{};
+    param.sched_priority = std::atoi(priority);
+    if (int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+      std::cerr << "could not set " << fifo_env << ": " << std::strerror(err) << std::endl;
     }
-
-    return pnl;
-  }
-
-  price_t get_bbo(ticker_t ticker, bool buy) const {
-    return books[ticker].get_bbo(buy);
-  }
-
-  price_t get_mid_price(ticker_t ticker, bool buy) const {
-    return books[ticker].get_mid_price(buy);
   }
 
-  price_t get_quote_size(ticker_t ticker, bool buy) const {
-    return books[ticker].quote_size(buy);
-  }
+  cpu_set_t cpus;
+  int policy;
+  sched_param param{};
+  pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  pthread_getschedparam(pthread_self(), &policy, &param);
 
-  price_t get_spread(ticker_t ticker) const {
-    return books[ticker].spread();
+  std::cout << "placement: " << name << " on cpus";
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &cpus)) {
+      std::cout << ' ' << cpu;
+    }
   }
-
-  void log_book() {
-    books[0].print_book(log_path, open_orders);
+  if (policy == SCHED_FIFO) {
+    std::cout << ", SCHED_FIFO " << param.sched_priority;
   }
-
-  trader_id_t trader_id;
-  MyBook books[MAX_NUM_TICKERS];
-  std::unordered_set<order_id_t> submitted;
-  std::unordered_map<order_id_t, Common::Order> open_orders;
-  price_t cash;
-  quantity_t positions[MAX_NUM_TICKERS];
-  quantity_t volume_traded;
-  price_t last_trade_price;
-  std::string log_path;
-
-};
+  std::cout << std::endl;
+}
 
 // Momentum Bot
 //
@@ -364,7 +107,7 @@ class MomentumBot : public Bot::AbstractBot {
 
 public:
 
-  MyState state;
+  MyState<MyBook> state;
 
   using Bot::AbstractBot::AbstractBot;
 
@@ -375,6 +118,7 @@ public:
 
   // (maybe) EDIT THIS METHOD
   void init(Bot::Communicator& com) {
+    place_current_thread("MomentumBot", "KIRIN_BOT_CPUS", "KIRIN_BOT_FIFO");
     state.trader_id = trader_id;
     state.log_path = "book.log";
     start_time = time_ns();
@@ -418,9 +162,9 @@ public:
     ///
 
     // a way to put in a bid of quantity 1 at the current best bid
-    price_t best_bid = state.get_bbo(0, true);
-    price_t best_offer = state.get_bbo(0, false);
-    price_t spread_size = state.get_spread(0);
+    tick_t best_bid = state.get_bbo(0, true);
+    tick_t best_offer = state.get_bbo(0, false);
+    tick_t spread_size = state.get_spread(0);
     quantity_t bid_quote_size = state.get_quote_size(0, true);
     quantity_t offer_quote_size = state.get_quote_size(0, false);
     price_t fair_price = weighted_price(best_bid, best_offer, bid_quote_size, offer_quote_size);
@@ -434,16 +178,17 @@ public:
 
 
     constexpr quantity_t position_limit = 1000;
+    const tick_t update_price = Common::to_ticks(update.price);
 
     // Momentum on top of book: Taking side on large orders
     // Other competitors are literally incapable of placing orders larger than 2000 -- due to their position limits.
     if (update.quantity > 2000) {
       // BUY side large order
-      if (update.buy && update.price > best_bid && state.positions[0] < position_limit) {
+      if (update.buy && update_price > best_bid && state.positions[0] < position_limit) {
         // Make a large IOC order to take best offers.
         order_id_t order_id = place_order(com, Common::Order{
           .ticker = 0,
-          .price = best_offer + 0.02,
+          .price = Common::to_price(best_offer + 2),
           .quantity = position_limit - state.positions[0],
           .buy = true,
           .ioc = true,
@@ -453,11 +198,11 @@ public:
 
         if (INFO) {
           std::cout << "BIG BUY DETECTED!" << std::endl;
-          std::cout << " -- best_bid         : " << best_bid << std::endl;
+          std::cout << " -- best_bid         : " << Common::to_price(best_bid) << std::endl;
           std::cout << " -- bid_quote_size   : " << bid_quote_size << std::endl;
-          std::cout << " -- best_offer       : " << best_offer << std::endl;
+          std::cout << " -- best_offer       : " << Common::to_price(best_offer) << std::endl;
           std::cout << " -- offer_quote_size : " << offer_quote_size << std::endl;
-          std::cout << " -- spread_size      : " << spread_size << std::endl;
+          std::cout << " -- spread_size      : " << Common::to_price(spread_size) << std::endl;
           std::cout << " -- fair_price       : " << fair_price << std::endl;
           std::cout << " ----------------------------------------" << std::endl;
           std::cout << " -- THEIR PRICE      : " << update.price << std::endl;
@@ -469,11 +214,11 @@ public:
         }
       }
 
-      if (!update.buy && update.price < best_offer && state.positions[0] > -position_limit) {
+      if (!update.buy && update_price < best_offer && state.positions[0] > -position_limit) {
         // Make a large IOC order to take best bids.
         order_id_t order_id = place_order(com, Common::Order{
           .ticker = 0,
-          .price = best_bid - 0.02,
+          .price = Common::to_price(best_bid - 2),
           .quantity = state.positions[0] + position_limit,
           .buy = false,
           .ioc = true,
@@ -483,11 +228,11 @@ public:
 
         if (INFO) {
           std::cout << "BIG SELL DETECTED!" << std::endl;
-          std::cout << " -- best_bid         : " << best_bid << std::endl;
+          std::cout << " -- best_bid         : " << Common::to_price(best_bid) << std::endl;
           std::cout << " -- bid_quote_size   : " << bid_quote_size << std::endl;
-          std::cout << " -- best_offer       : " << best_offer << std::endl;
+          std::cout << " -- best_offer       : " << Common::to_price(best_offer) << std::endl;
           std::cout << " -- offer_quote_size : " << offer_quote_size << std::endl;
-          std::cout << " -- spread_size      : " << spread_size << std::endl;
+          std::cout << " -- spread_size      : " << Common::to_price(spread_size) << std::endl;
           std::cout << " -- fair_price       : " << fair_price << std::endl;
           std::cout << " ----------------------------------------" << std::endl;
           std::cout << " -- THEIR PRICE      : " << update.price << std::endl;
@@ -506,12 +251,12 @@ public:
     // price_t weighted_price = (best_bid * bid_quote_size + best_offer * offer_quote_size) / (bid_quote_size + offer_quote_size);
     
     /*
-    if (spread_size < 2 && spread_size > 0.2 && update.quantity <= 100){
+    if (spread_size < 200 && spread_size > 20 && update.quantity <= 100){
 
       quantity_t order_size = update.quantity > 100 ? 100 : update.quantity;
 
       // if the order crosses the weighted spread, send an IOC to hit it.
-      if (update.buy && update.price > fair_price + 0.02) {
+      if (update.buy && update_price > Common::to_ticks(fair_price) + 2) {
         order_id_t order_id = place_order(com, Common::Order{
           .ticker = 0,
           .price = update.price,
@@ -524,11 +269,11 @@ public:
 
         if (INFO) {
           std::cout << "SHIT BUY DETECTED!" << std::endl;
-          std::cout << " -- best_bid         : " << best_bid << std::endl;
+          std::cout << " -- best_bid         : " << Common::to_price(best_bid) << std::endl;
           std::cout << " -- bid_quote_size   : " << bid_quote_size << std::endl;
-          std::cout << " -- best_offer       : " << best_offer << std::endl;
+          std::cout << " -- best_offer       : " << Common::to_price(best_offer) << std::endl;
           std::cout << " -- offer_quote_size : " << offer_quote_size << std::endl;
-          std::cout << " -- spread_size      : " << spread_size << std::endl;
+          std::cout << " -- spread_size      : " << Common::to_price(spread_size) << std::endl;
           std::cout << " -- fair_price       : " << fair_price << std::endl;
           std::cout << " ----------------------------------------" << std::endl;
           std::cout << " -- THEIR PRICE      : " << update.price << std::endl;
@@ -539,7 +284,7 @@ public:
           std::cout << " ----------------------------------------" << std::endl;
         }
       }
-      else if (!update.buy && update.price < fair_price - 0.02) {
+      else if (!update.buy && update_price < Common::to_ticks(fair_price) - 2) {
         order_id_t order_id = place_order(com, Common::Order{
           .ticker = 0,
           .price = update.price,
@@ -552,11 +297,11 @@ public:
 
         if (INFO) {
           std::cout << "SHIT SELL DETECTED!" << std::endl;
-          std::cout << " -- best_bid         : " << best_bid << std::endl;
+          std::cout << " -- best_bid         : " << Common::to_price(best_bid) << std::endl;
           std::cout << " -- bid_quote_size   : " << bid_quote_size << std::endl;
-          std::cout << " -- best_offer       : " << best_offer << std::endl;
+          std::cout << " -- best_offer       : " << Common::to_price(best_offer) << std::endl;
           std::cout << " -- offer_quote_size : " << offer_quote_size << std::endl;
-          std::cout << " -- spread_size      : " << spread_size << std::endl;
+          std::cout << " -- spread_size      : " << Common::to_price(spread_size) << std::endl;
           std::cout << " -- fair_price       : " << fair_price << std::endl;
           std::cout << " ----------------------------------------" << std::endl;
           std::cout << " -- THEIR PRICE      : " << update.price << std::endl;
@@ -576,23 +321,17 @@ public:
       state.log_book();
 
       std::cout << now << ": " << std::endl;
-      std::cout << " -- best_bid : " << best_bid << std::endl;
+      std::cout << " -- best_bid : " << Common::to_price(best_bid) << std::endl;
       std::cout << " -- bid_quote_size : " << bid_quote_size << std::endl;
-      std::cout << " -- best_offer : " << best_offer << std::endl;
+      std::cout << " -- best_offer : " << Common::to_price(best_offer) << std::endl;
       std::cout << " -- offer_quote_size : " << offer_quote_size << std::endl;
-      std::cout << " -- spread_size : " << spread_size << std::endl;
+      std::cout << " -- spread_size : " << Common::to_price(spread_size) << std::endl;
       last = now;
     }
 
 
     // a way to cancel all your open orders
-    // for (const auto& x : state.open_orders) {
-    //   place_cancel(com, Common::Cancel{
-    //     .ticker = 0,
-    //     .order_id = x.first,
-    //     .trader_id = trader_id
-    //   });
-    // }
+    // cancel_all(com, 0);
 
 
     // a way to get your current position
@@ -600,11 +339,11 @@ public:
 
 
     // MARKET MAKING CODE
-    // if (best_bid != 0.0 && best_offer != 0.0 && spread_size >= 0.1 && std::abs(position) < 20) { // 0.0 denotes no bid
+    // if (best_bid != 0 && best_offer != 0 && spread_size >= 10 && std::abs(position) < 20) { // 0 denotes no bid
 
     //   place_order(com, Common::Order{
     //     .ticker = 0,
-    //     .price = best_bid + 0.01,
+    //     .price = Common::to_price(best_bid + 1),
     //     .quantity = 1,
     //     .buy = true,
     //     .ioc = false,
@@ -615,7 +354,7 @@ public:
 
     //   place_order(com, Common::Order{
     //     .ticker = 0,
-    //     .price = best_offer - 0.01,
+    //     .price = Common::to_price(best_offer - 1),
     //     .quantity = 1,
     //     .buy = false,
     //     .ioc = false,
@@ -625,7 +364,7 @@ public:
     //   ++last_order_id;
 
     //   if (INFO) {
-    //     std::cout << "Placing spread " << best_bid+0.01 << ", " << best_offer-0.01 << std::endl;
+    //     std::cout << "Placing spread " << Common::to_price(best_bid + 1) << ", " << Common::to_price(best_offer - 1) << std::endl;
     //   }
     // }
 
@@ -695,6 +434,23 @@ public:
     com.place_cancel(cancel);
   }
 
+  // Cancels every order we have resting on ticker, found through the
+  // own-order level index rather than a scan of all open orders.
+  void cancel_all(Bot::Communicator& com, ticker_t ticker) {
+    const MyState<MyBook>& current = state; // const, so no TickerState is created
+    for (const auto& side : current.ticker_state(ticker).own_levels) {
+      for (const auto& level : side) {
+        for (order_id_t order_id : level.second.order_ids) {
+          place_cancel(com, Common::Cancel{
+            .ticker = ticker,
+            .order_id = order_id,
+            .trader_id = trader_id
+          });
+        }
+      }
+    }
+  }
+
 };
 
 // LogBot
@@ -706,7 +462,7 @@ class LogBot: public Bot::AbstractBot {
 
 public:
 
-  MyState state;
+  MyState<MyBook> state;
 
   using Bot::AbstractBot::AbstractBot;
 
@@ -727,21 +483,21 @@ public:
 
   void write_to_csv(std::string type, order_id_t order_id, bool buy, price_t price, quantity_t qty) {
     int64_t curr = time_ns() - start_time;
-    price_t best_bid = state.get_bbo(0, true);
-    price_t best_offer = state.get_bbo(0, false);
+    tick_t best_bid = state.get_bbo(0, true);
+    tick_t best_offer = state.get_bbo(0, false);
     quantity_t bid_quote_size = state.get_quote_size(0, true);
     quantity_t offer_quote_size = state.get_quote_size(0, false);
 
     prices_file << curr << ",";
-    prices_file << best_bid << ",";
-    prices_file << best_offer << ",";
+    prices_file << Common::to_price(best_bid) << ",";
+    prices_file << Common::to_price(best_offer) << ",";
     prices_file << bid_quote_size << ",";
     prices_file << offer_quote_size << ",";
     prices_file << cube_root_price(best_bid, best_offer, bid_quote_size, offer_quote_size) << ",";
     prices_file << square_root_price(best_bid, best_offer, bid_quote_size, offer_quote_size) << ",";
     prices_file << weighted_price(best_bid, best_offer, bid_quote_size, offer_quote_size) << ",";
     prices_file << square_price(best_bid, best_offer, bid_quote_size, offer_quote_size) << ",";
-    prices_file << (best_bid + best_offer) / 2 << ",";
+    prices_file << 0.5 * Common::to_price(best_bid + best_offer) << ",";
     prices_file << type << ",";
     prices_file << order_id << ",";
     prices_file << (buy ? 1 : 0) << ",";
@@ -823,6 +579,7 @@ int main() {
 
   manager.register_bot(m);
 
+  place_current_thread("manager", "KIRIN_CPUS", "KIRIN_FIFO");
   manager.run();
 
   return 0;
@@ -350,13 +350,7 @@ public:
 
 
     // a way to cancel all your open orders
-    for (const auto& x : state.open_orders) {
-      place_cancel(com, Common::Cancel{
-        .ticker = 0,
-        .order_id = x.first,
-        .trader_id = trader_id
-      });
-    }
+    cancel_all(com, 0);
 
 
     // a way to get your current position
@@ -433,6 +427,18 @@ public:
     com.place_cancel(cancel);
   }
 
+  void cancel_all(Bot::Communicator& com, ticker_t ticker) {
+    for (const auto& x : state.open_orders) {
+      if (x.second.ticker == ticker) {
+        place_cancel(com, Common::Cancel{
+          .ticker = ticker,
+          .order_id = x.first,
+          .trader_id = trader_id
+        });
+      }
+    }
+  }
+
 };
 
 
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cstdint>
 #include <random>
 #include <string>
@@ -11,9 +13,11 @@ typedef int64_t quantity_t;
 typedef uint64_t order_id_t;
 typedef uint64_t trader_id_t;
 typedef double price_t;
+typedef int64_t tick_t;
 typedef uint8_t ticker_t;
 const int MAX_NUM_TICKERS = 256;
 const uint64_t MAX_MESSAGES = UINT64_MAX;
+const tick_t TICKS_PER_UNIT = 100;
 
 
 namespace Common {
@@ -22,6 +26,16 @@ namespace Common {
     return round(price * 100.0) / 100.0;
   }
 
+  // Integer tick prices. The wire structs below still carry price_t, so
+  // convert once on the way in and only go back to price_t for display.
+  static inline tick_t to_ticks(price_t price) {
+    return llround(price * TICKS_PER_UNIT);
+  }
+
+  static inline price_t to_price(tick_t ticks) {
+    return (price_t)ticks / TICKS_PER_UNIT;
+  }
+
 
   struct Order {
     // TODO sort these fields by size for struct packing
@@ -0,0 +1,181 @@
+// Offline book replay
+//
+// Rebuilds the book updates LogBot recorded in prices.csv, checks MyBook
+// against the reference SetBook after every one of them, then times each
+// book, and the order-id map choices behind MyBook::order_map, on the same
+// stream:
+//
+//   ./replay [prices.csv] [repeats]
+
+#include "kirin.hpp"
+#include "client.hpp"
+#include "checked_book.hpp"
+#include <cassert>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <cstdlib>
+#include <unordered_map>
+
+// Book Events
+//
+// One book update read back from the log; for DECREASE, order.quantity is
+// the traded quantity.
+struct BookEvent {
+  enum Type { INSERT, CANCEL, DECREASE };
+
+  Type type;
+  Common::Order order;
+};
+
+// Reads the ORDER, CANCEL and TRADE rows of a prices.csv. Trades are logged
+// under the aggressing order id, so the resting order is taken to be the
+// first in time priority at the trade price on the other side, which is the
+// one the exchange matches against.
+std::vector<BookEvent> read_events(const std::string& path, size_t& unmatched) {
+  std::vector<BookEvent> events;
+  SetBook book;
+
+  std::ifstream fin(path);
+  std::string line;
+  std::getline(fin, line); // header
+
+  while (std::getline(fin, line)) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+      fields.push_back(field);
+    }
+    if (fields.size() < 15) {
+      continue;
+    }
+
+    const std::string& type = fields[10];
+    Common::Order order{};
+    order.order_id = std::stoull(fields[11]);
+    order.buy = fields[12] == "1";
+    order.price = std::stod(fields[13]);
+    order.quantity = std::stoll(fields[14]);
+
+    if (type == "ORDER") {
+      events.push_back(BookEvent{BookEvent::INSERT, order});
+      book.insert(order);
+
+    } else if (type == "CANCEL") {
+      events.push_back(BookEvent{BookEvent::CANCEL, order});
+      book.cancel(0, order.order_id);
+
+    } else if (type == "TRADE") {
+      order.order_id = book.first_at(!order.buy, Common::to_ticks(order.price));
+      if (order.order_id == 0) {
+        unmatched++;
+        continue;
+      }
+      events.push_back(BookEvent{BookEvent::DECREASE, order});
+      book.decrease_qty(order.order_id, order.quantity);
+    }
+  }
+
+  return events;
+}
+
+template <typename Book>
+void apply(Book& book, const BookEvent& event) {
+  switch (event.type) {
+    case BookEvent::INSERT: book.insert(event.order); break;
+    case BookEvent::CANCEL: book.cancel(event.order.trader_id, event.order.order_id); break;
+    case BookEvent::DECREASE: book.decrease_qty(event.order.order_id, event.order.quantity); break;
+  }
+}
+
+// Replays events into a fresh Book repeats times, reading the top of book
+// after each update, and returns ns per update.
+template <typename Book>
+double time_replay(const std::vector<BookEvent>& events, int repeats) {
+  int64_t start = time_ns();
+  for (int i = 0; i < repeats; i++) {
+    Book book;
+    for (const BookEvent& event : events) {
+      apply(book, event);
+      volatile tick_t best = book.get_bbo(true) + book.get_bbo(false);
+      (void)best;
+    }
+  }
+  return (double)(time_ns() - start) / (events.size() * repeats);
+}
+
+// Replays the order ids of events through a Map from id to resting
+// quantity, inserting, finding and erasing the way MyBook::order_map does,
+// and returns ns per update.
+template <typename Map>
+double time_id_map(const std::vector<BookEvent>& events, int repeats) {
+  size_t resting = 0;
+  int64_t start = time_ns();
+  for (int i = 0; i < repeats; i++) {
+    Map map;
+    for (const BookEvent& event : events) {
+      const order_id_t order_id = event.order.order_id;
+      if (event.type == BookEvent::INSERT) {
+        map.emplace(order_id, event.order.quantity);
+        continue;
+      }
+
+      auto it = map.find(order_id);
+      if (it == map.end()) {
+        continue;
+      }
+      if (event.type == BookEvent::CANCEL || (it->second -= event.order.quantity) <= 0) {
+        map.erase(it);
+      }
+    }
+    resting += map.size();
+  }
+  int64_t elapsed = time_ns() - start;
+
+  volatile size_t sink = resting;
+  (void)sink;
+  return (double)elapsed / (events.size() * repeats);
+}
+
+int main(int argc, char** argv) {
+
+  const std::string path = argc > 1 ? argv[1] : "prices.csv";
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  size_t unmatched = 0;
+  const std::vector<BookEvent> events = read_events(path, unmatched);
+  if (events.empty() || repeats <= 0) {
+    std::cerr << "usage: ./replay [prices.csv] [repeats]" << std::endl;
+    return 1;
+  }
+
+  std::cout << events.size() << " book updates from " << path;
+  if (unmatched) {
+    std::cout << " (" << unmatched << " trades with no resting order skipped)";
+  }
+  std::cout << std::endl;
+
+  CheckedBook<SetBook, MyBook> checked;
+  for (const BookEvent& event : events) {
+    apply(checked, event);
+  }
+  std::cout << "MyBook agrees with SetBook after every update" << std::endl;
+
+  std::cout << "SetBook " << time_replay<SetBook>(events, repeats) << " ns/update" << std::endl;
+  std::cout << "MyBook  " << time_replay<MyBook>(events, repeats) << " ns/update" << std::endl;
+
+  std::cout << "order id maps:" << std::endl;
+  std::cout << "  std::unordered_map       "
+            << time_id_map<std::unordered_map<order_id_t, quantity_t>>(events, repeats)
+            << " ns/update" << std::endl;
+  std::cout << "  ska::flat_hash_map       "
+            << time_id_map<ska::flat_hash_map<order_id_t, quantity_t>>(events, repeats)
+            << " ns/update" << std::endl;
+  std::cout << "  OrderIdMap (OrderIdHash) "
+            << time_id_map<OrderIdMap<quantity_t>>(events, repeats)
+            << " ns/update" << std::endl;
+
+  return 0;
+}